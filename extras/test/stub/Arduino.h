@@ -0,0 +1,91 @@
+/**
+ * Minimal host stand-in for the Arduino core, used by the unit tests.
+ * Only the parts of Print, Stream and String used by the library exist.
+ */
+
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define F(str) (str)
+#define DEC 10
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size) {
+		size_t count = 0;
+		while (size--) count += write(*buffer++);
+		return count;
+	}
+	size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+	size_t write(const char *str) { return write(str, strlen(str)); }
+
+	size_t print(const char *str) { return str ? write(str) : 0; }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(const std::string &str) { return print(str.c_str()); }
+	size_t print(long value, int = DEC) { char buf[24]; snprintf(buf, sizeof(buf), "%ld", value); return print(buf); }
+	size_t print(int value, int = DEC) { return print((long)value); }
+	size_t print(double value, int digits = 2) { char buf[48]; snprintf(buf, sizeof(buf), "%.*f", digits, value); return print(buf); }
+	size_t println() { return write("\r\n"); }
+	template <class T> size_t println(T value) { return print(value) + println(); }
+	template <class T> size_t println(T value, int digits) { return print(value, digits) + println(); }
+};
+
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	size_t readBytes(char *buffer, size_t length) {
+		size_t count = 0;
+		while (count < length) {
+			int c = read();
+			if (c < 0) break;
+			buffer[count++] = c;
+		}
+		return count;
+	}
+};
+
+class String : public std::string {
+public:
+	String() {}
+	String(const char *str) : std::string(str ? str : "") {}
+	String &operator=(const char *str) { assign(str ? str : ""); return *this; }
+	bool concat(const char *str, unsigned int length) { append(str, length); return true; }
+	void trim() {
+		size_t first = find_first_not_of(" \t\r\n");
+		if (first == npos) { clear(); return; }
+		size_t last = find_last_not_of(" \t\r\n");
+		assign(substr(first, last - first + 1));
+	}
+};
+
+// Serial output goes to serial.log, to keep it apart from the test
+// results and from any sanitizer reports on stderr
+class HardwareSerial : public Stream {
+public:
+	HardwareSerial() : log(NULL) {}
+	size_t write(uint8_t c) override {
+		if (!log) log = fopen("serial.log", "a");
+		if (log) fputc(c, log);
+		return 1;
+	}
+	int available() override { return 0; }
+	int read() override { return -1; }
+	int peek() override { return -1; }
+
+private:
+	FILE *log;
+};
+
+extern HardwareSerial Serial;
+
+#endif /* ARDUINO_STUB_H */
@@ -0,0 +1,199 @@
+/**
+ * Minimal host stand-in for the SdFat library, used by the unit tests.
+ *
+ * Files are stored on the host file system, relative to the working
+ * directory. Every call which has to look up a path in the directory
+ * tree is counted in "sdOps", so the tests can check how much directory
+ * traffic each operation causes.
+ */
+
+#ifndef SDFAT_STUB_H
+#define SDFAT_STUB_H
+
+#include "Arduino.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define O_AT_END   0x4000000
+#define FILE_READ  O_RDONLY
+#define FILE_WRITE (O_RDWR | O_CREAT | O_AT_END)
+
+struct SdOpCounts {
+	int begin;
+	int exists;
+	int open;
+	int openNext;
+	int remove;
+	int rename;
+	int seekFailures;
+	int unclosed;
+	long bytesRead;
+};
+
+extern SdOpCounts sdOps;
+
+class File32 : public Stream {
+public:
+	File32() : fp(NULL), isDirectory(false), nextEntry(0) {}
+	// SdFat doesn't close files when they go out of scope, so these are counted
+	~File32() {
+		if (isOpen()) sdOps.unclosed++;
+		close();
+	}
+
+	// Like SdFat, opening fails if this file object is already in use
+	bool open(const char *filePath, int oflag = O_RDONLY) {
+		sdOps.open++;
+		if (isOpen()) return false;
+		name = strrchr(filePath, '/') ? strrchr(filePath, '/') + 1 : filePath;
+		return openPath(filePath, oflag);
+	}
+
+	bool open(File32 *dirFile, const char *fileName, int oflag = O_RDONLY) {
+		sdOps.open++;
+		if (isOpen()) return false;
+		name = fileName;
+		return openPath((dirFile->path + "/" + fileName).c_str(), oflag);
+	}
+
+	bool openNext(File32 *dirFile, int oflag = O_RDONLY) {
+		sdOps.openNext++;
+		if (isOpen() || dirFile->nextEntry >= dirFile->entries.size()) return false;
+		name = dirFile->entries[dirFile->nextEntry++];
+		return openPath((dirFile->path + "/" + name).c_str(), oflag);
+	}
+
+	bool close() {
+		if (fp) fclose(fp);
+		fp = NULL;
+		isDirectory = false;
+		entries.clear();
+		return true;
+	}
+
+	bool isOpen() const { return fp != NULL || isDirectory; }
+	operator bool() const { return isOpen(); }
+	bool isDir() const { return isDirectory; }
+
+	size_t getName(char *buffer, size_t size) {
+		if (name.size() + 1 > size) return 0;
+		strcpy(buffer, name.c_str());
+		return name.size();
+	}
+
+	void rewindDirectory() { nextEntry = 0; }
+
+	int available() override { return fp ? (int)(fileSize() - curPosition()) : 0; }
+	int read() override { return fp ? fgetc(fp) : -1; }
+	int read(void *buffer, size_t size) { return fp ? (int)fread(buffer, 1, size, fp) : -1; }
+	int peek() override {
+		int c = read();
+		if (c >= 0) ungetc(c, fp);
+		return c;
+	}
+
+	// Same behaviour as SdFat: '\r' is dropped and '\n' is kept
+	int fgets(char *str, int num) {
+		int n = 0;
+		int c = EOF;
+		while (n + 1 < num && (c = read()) != EOF) {
+			if (c == '\r') continue;
+			str[n++] = c;
+			if (c == '\n') break;
+		}
+		str[n] = '\0';
+		sdOps.bytesRead += n;
+		return n;
+	}
+
+	size_t write(uint8_t c) override { return fp ? fwrite(&c, 1, 1, fp) : 0; }
+	size_t write(const uint8_t *buffer, size_t size) override { return fp ? fwrite(buffer, 1, size, fp) : 0; }
+	using Print::write;
+
+	// Like SdFat, seeking past the end of the file fails
+	bool seekSet(uint32_t pos) {
+		if (fp && pos <= fileSize() && fseek(fp, pos, SEEK_SET) == 0) return true;
+		sdOps.seekFailures++;
+		return false;
+	}
+	uint32_t curPosition() { return fp ? ftell(fp) : 0; }
+	uint32_t fileSize() {
+		if (!fp) return 0;
+		long pos = ftell(fp);
+		fseek(fp, 0, SEEK_END);
+		long size = ftell(fp);
+		fseek(fp, pos, SEEK_SET);
+		return size;
+	}
+
+	bool rename(const char *newPath) {
+		sdOps.rename++;
+		if (!fp) return false;
+		struct stat st;
+		if (stat(newPath, &st) == 0) return false;
+		long pos = ftell(fp);
+		fclose(fp);
+		if (::rename(path.c_str(), newPath) != 0) {
+			fp = fopen(path.c_str(), "r+b");
+			return false;
+		}
+		path = newPath;
+		fp = fopen(path.c_str(), "r+b");
+		fseek(fp, pos, SEEK_SET);
+		return true;
+	}
+
+private:
+	bool openPath(const char *filePath, int oflag) {
+		path = filePath;
+
+		struct stat st;
+		bool exists = (stat(filePath, &st) == 0);
+		if (exists && S_ISDIR(st.st_mode)) {
+			DIR *dir = opendir(filePath);
+			for (struct dirent *entry; (entry = readdir(dir)) != NULL;) {
+				if (entry->d_name[0] != '.') entries.push_back(entry->d_name);
+			}
+			closedir(dir);
+			isDirectory = true;
+			nextEntry = 0;
+			return true;
+		}
+
+		if (!exists && !(oflag & O_CREAT)) return false;
+		if ((oflag & O_ACCMODE) == O_RDONLY) fp = fopen(filePath, "rb");
+		else if ((oflag & O_TRUNC) || !exists) fp = fopen(filePath, "w+b");
+		else fp = fopen(filePath, "r+b");
+		if (fp && (oflag & O_AT_END)) fseek(fp, 0, SEEK_END);
+		return fp != NULL;
+	}
+
+	FILE *fp;
+	std::string path;
+	std::string name;
+	bool isDirectory;
+	std::vector<std::string> entries;
+	size_t nextEntry;
+};
+
+class SdFat32 {
+public:
+	bool begin(uint8_t) { sdOps.begin++; return true; }
+	void initErrorPrint(Print *) {}
+	bool exists(const char *path) {
+		sdOps.exists++;
+		struct stat st;
+		return stat(path, &st) == 0;
+	}
+	bool remove(const char *path) {
+		sdOps.remove++;
+		return ::remove(path) == 0;
+	}
+};
+
+#endif /* SDFAT_STUB_H */
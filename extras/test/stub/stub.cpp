@@ -0,0 +1,8 @@
+/**
+ * Global objects of the Arduino and SdFat host stand-ins
+ */
+
+#include "SdFat.h"
+
+HardwareSerial Serial;
+SdOpCounts sdOps;
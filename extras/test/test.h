@@ -0,0 +1,56 @@
+/**
+ * Shared helpers for the SdConfigFile host unit tests
+ */
+
+#ifndef SD_CONFIG_FILE_TEST_H
+#define SD_CONFIG_FILE_TEST_H
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+
+static int testFailures = 0;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		testFailures++; \
+	} \
+} while (0)
+
+#define CHECK_EQUAL(actual, expected) do { \
+	if (!((actual) == (expected))) { \
+		printf("%s:%d: check failed: %s == %s\n", __FILE__, __LINE__, #actual, #expected); \
+		testFailures++; \
+	} \
+} while (0)
+
+// Write a file with the given contents
+inline void writeTestFile(const char *fileName, const std::string &contents) {
+	FILE *fp = fopen(fileName, "wb");
+	fwrite(contents.data(), 1, contents.size(), fp);
+	fclose(fp);
+}
+
+// Read a file back, without the '\r' line ending characters
+inline std::string readTestFile(const char *fileName) {
+	std::string contents;
+	FILE *fp = fopen(fileName, "rb");
+	if (!fp) return contents;
+	for (int c; (c = fgetc(fp)) != EOF;) {
+		if (c != '\r') contents += (char)c;
+	}
+	fclose(fp);
+	return contents;
+}
+
+inline void resetOpCounts() {
+	sdOps = SdOpCounts();
+}
+
+inline int testResult(const char *testName) {
+	printf("%s: %s\n", testName, testFailures ? "FAILED" : "passed");
+	return testFailures ? 1 : 0;
+}
+
+#endif /* SD_CONFIG_FILE_TEST_H */
@@ -0,0 +1,88 @@
+/**
+ * Check that all config files in a directory are read in name order,
+ * with only a few passes over the directory
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+#include <sys/stat.h>
+#include <vector>
+
+SdConfigFile configFile(10);
+std::vector<std::string> entriesRead;
+
+void readConfigCallback() {
+	SdConfigFile::Entry entry = configFile.entry();
+	entriesRead.push_back(std::string(entry.file) + ":" + entry.key + "=" + entry.value);
+}
+
+int main() {
+
+	// Create the fragments in a shuffled order, along with some files which should be skipped
+	mkdir("conf.d", 0755);
+	mkdir("conf.d/sub.cfg", 0755);
+	writeTestFile("conf.d/notes.txt", "skip=1\n");
+	writeTestFile("conf.d/a_file_name_which_is_too_long_for_the_buffer.cfg", "skip=1\n");
+
+	for (int i = 0; i < 30; i++) {
+		int number = (i * 7) % 30;
+		char fileName[32];
+		char contents[32];
+		snprintf(fileName, sizeof(fileName), "conf.d/%02d-module.cfg", number);
+		snprintf(contents, sizeof(contents), "# module %d\nvalue=%d\n", number, number);
+		writeTestFile(fileName, contents);
+	}
+
+	// 30 fragments need 4 passes over the 33 directory entries
+	resetOpCounts();
+	CHECK(configFile.readDirectory("conf.d", ".cfg", readConfigCallback));
+	CHECK_EQUAL(sdOps.begin, 1);
+	CHECK_EQUAL(sdOps.exists, 0);
+	CHECK_EQUAL(sdOps.open, 31);
+	CHECK_EQUAL(sdOps.openNext, 4 * 34);
+
+	CHECK_EQUAL(entriesRead.size(), 30u);
+	for (int i = 0; i < 30 && i < (int)entriesRead.size(); i++) {
+		char expected[48];
+		snprintf(expected, sizeof(expected), "%02d-module.cfg:value=%d", i, i);
+		CHECK_EQUAL(entriesRead[i], expected);
+	}
+	CHECK(configFile.entry().file == NULL);
+
+	// A few files only need a single pass
+	mkdir("small.d", 0755);
+	writeTestFile("small.d/b.CFG", "b=2\n");
+	writeTestFile("small.d/a.cfg", "a=1\n");
+	entriesRead.clear();
+	resetOpCounts();
+	CHECK(configFile.readDirectory("small.d", ".cfg", readConfigCallback));
+	CHECK_EQUAL(sdOps.openNext, 3);
+	CHECK_EQUAL(entriesRead.size(), 2u);
+	if (entriesRead.size() == 2) {
+		CHECK_EQUAL(entriesRead[0], "a.cfg:a=1");
+		CHECK_EQUAL(entriesRead[1], "b.CFG:b=2");
+	}
+
+	CHECK(!configFile.readDirectory("missing.d", ".cfg", readConfigCallback));
+
+	// The directory can't be read while a file is being written,
+	// and the file being written is left as it was
+	writeTestFile("w.cfg", "ww=1\nzz=9\n");
+	entriesRead.clear();
+	bool directoryRead = false;
+	while (configFile.write("w.cfg")) {
+		if (configFile.readDirectory("small.d", ".cfg", readConfigCallback)) directoryRead = true;
+		configFile.set("zz", 10);
+	}
+	CHECK(!directoryRead);
+	CHECK_EQUAL(entriesRead.size(), 0u);
+	CHECK_EQUAL(readTestFile("w.cfg"), "ww=1\nzz=10\n");
+
+	// A path which isn't a directory is closed again
+	resetOpCounts();
+	CHECK(!configFile.readDirectory("small.d/a.cfg", ".cfg", readConfigCallback));
+	CHECK_EQUAL(sdOps.unclosed, 0);
+
+	return testResult("test_directory");
+}
@@ -0,0 +1,81 @@
+/**
+ * Check that range-based for loops over the entries of a config file
+ * always start at the top of the file, and report long values as partial
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+#include <vector>
+
+SdConfigFile configFile(10);
+
+// List the "key=value" strings of all entries in a file
+std::vector<std::string> listEntries(const char *fileName) {
+	std::vector<std::string> entries;
+	for (auto entry : configFile.entries(fileName)) {
+		entries.push_back(std::string(entry.key) + "=" + entry.value);
+	}
+	return entries;
+}
+
+int main() {
+
+	std::string longValue(3 * SDCONFIG_BUFFER_LENGTH, 'x');
+	writeTestFile("e.cfg", "# comment\na=1\nlong=" + longValue + "\nb=2\n");
+	writeTestFile("o.cfg", "c=3\nd=4\n");
+
+	// Comments are skipped
+	std::vector<std::string> entries = listEntries("o.cfg");
+	CHECK_EQUAL(entries.size(), 2u);
+	if (entries.size() == 2) {
+		CHECK_EQUAL(entries[0], "c=3");
+		CHECK_EQUAL(entries[1], "d=4");
+	}
+
+	// Leaving a loop early doesn't affect the next loop over another file
+	for (auto entry : configFile.entries("e.cfg")) {
+		if (strcmp(entry.key, "a") == 0) break;
+	}
+	entries = listEntries("o.cfg");
+	CHECK_EQUAL(entries.size(), 2u);
+	if (entries.size() == 2) CHECK_EQUAL(entries[0], "c=3");
+
+	// Or over the same file
+	for (auto entry : configFile.entries("e.cfg")) {
+		if (strcmp(entry.key, "long") == 0) break;
+	}
+	int count = 0;
+	for (auto entry : configFile.entries("e.cfg")) {
+		if (count == 0) CHECK_EQUAL(std::string(entry.key), "a");
+		count++;
+	}
+	CHECK_EQUAL(count, 3);
+
+	// Long values are partial, and can be retrieved in full using "get"
+	String value;
+	std::vector<std::string> keys;
+	for (auto entry : configFile.entries("e.cfg")) {
+		keys.push_back(entry.key);
+		if (strcmp(entry.key, "long") == 0) {
+			CHECK(entry.partial);
+			CHECK(configFile.get(entry.key, value));
+		} else {
+			CHECK(!entry.partial);
+		}
+	}
+	CHECK_EQUAL(std::string(value), longValue);
+	CHECK_EQUAL(keys.size(), 3u);
+	if (keys.size() == 3) CHECK_EQUAL(keys[2], "b");
+
+	// Partial values which aren't retrieved are skipped
+	keys.clear();
+	for (auto entry : configFile.entries("e.cfg")) keys.push_back(entry.key);
+	CHECK_EQUAL(keys.size(), 3u);
+
+	// A missing file has no entries, and doesn't affect the next loop
+	CHECK_EQUAL(listEntries("missing.cfg").size(), 0u);
+	CHECK_EQUAL(listEntries("o.cfg").size(), 2u);
+
+	return testResult("test_entries");
+}
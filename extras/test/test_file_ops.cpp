@@ -0,0 +1,63 @@
+/**
+ * Check the number of directory lookups (exists, open, remove and rename)
+ * needed to read and write a config file in a nested directory
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+SdConfigFile configFile(10);
+
+int main() {
+
+	mkdir("a", 0755);
+	mkdir("a/b", 0755);
+	mkdir("a/b/c", 0755);
+	remove("a/b/c/ops.cfg");
+
+	// Writing a new file: create the temporary file, try to open the
+	// config file, try to remove it and rename the temporary file
+	resetOpCounts();
+	while (configFile.write("a/b/c/ops.cfg")) {
+		configFile.set("x", 1);
+	}
+	CHECK_EQUAL(sdOps.exists, 0);
+	CHECK_EQUAL(sdOps.open, 2);
+	CHECK_EQUAL(sdOps.remove, 1);
+	CHECK_EQUAL(sdOps.rename, 1);
+	CHECK_EQUAL(readTestFile("a/b/c/ops.cfg"), "x=1\n");
+
+	// Writing an existing file
+	resetOpCounts();
+	while (configFile.write("a/b/c/ops.cfg")) {
+		configFile.set("x", 2);
+		configFile.set("y", 3);
+	}
+	CHECK_EQUAL(sdOps.exists, 0);
+	CHECK_EQUAL(sdOps.open, 2);
+	CHECK_EQUAL(sdOps.remove, 1);
+	CHECK_EQUAL(sdOps.rename, 1);
+	CHECK_EQUAL(readTestFile("a/b/c/ops.cfg"), "x=2\ny=3\n");
+
+	// Reading only needs to open the file
+	int x = 0;
+	resetOpCounts();
+	while (configFile.read("a/b/c/ops.cfg")) {
+		configFile.get("x", x);
+	}
+	CHECK_EQUAL(sdOps.exists, 0);
+	CHECK_EQUAL(sdOps.open, 1);
+	CHECK_EQUAL(sdOps.remove, 0);
+	CHECK_EQUAL(sdOps.rename, 0);
+	CHECK_EQUAL(x, 2);
+
+	// A missing file is reported by the failed open
+	resetOpCounts();
+	CHECK(!configFile.read("a/b/c/missing.cfg"));
+	CHECK_EQUAL(sdOps.exists, 0);
+	CHECK_EQUAL(sdOps.open, 1);
+
+	return testResult("test_file_ops");
+}
@@ -0,0 +1,132 @@
+/**
+ * Check that long values are written and read back in chunks, and that
+ * line endings in the chunks are escaped, rather than splitting the entry
+ * over several lines
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+SdConfigFile configFile(10);
+
+static std::string source;
+static size_t sourcePos;
+
+// Fill the chunk with the next part of the source string
+int sourceChunk(char *chunk, int maxLength) {
+	int length = std::min((size_t)maxLength, source.size() - sourcePos);
+	memcpy(chunk, source.data() + sourcePos, length);
+	sourcePos += length;
+	return length;
+}
+
+static std::string chunks;
+
+// Collect the chunks of a value
+void collectChunk(const char *chunk, int length) {
+	chunks.append(chunk, length);
+}
+
+// Write a value using the chunked "set" method, and read it back with the chunked "get"
+std::string roundTrip(const std::string &original) {
+	source = original;
+	sourcePos = 0;
+	while (configFile.write("trip.cfg")) {
+		configFile.set("value", sourceChunk);
+	}
+
+	chunks.clear();
+	while (configFile.read("trip.cfg")) {
+		configFile.get("value", collectChunk);
+	}
+	return chunks;
+}
+
+int main() {
+
+	std::string body;
+	for (int i = 0; i < 4; i++) body += std::string(64, 'A' + i);
+
+	// A PEM style certificate, read from a file with Windows line endings
+	source = "-----BEGIN CERTIFICATE-----\r\n";
+	for (int i = 0; i < 4; i++) source += body.substr(i * 64, 64) + "\r\n";
+	source += "-----END CERTIFICATE-----\r\n";
+	sourcePos = 0;
+
+	writeTestFile("long.cfg", "a=1\ncert=old\nb=2\n");
+	while (configFile.write("long.cfg")) {
+		configFile.set("cert", sourceChunk);
+	}
+	std::string escaped = "-----BEGIN CERTIFICATE-----\\r\\n";
+	for (int i = 0; i < 4; i++) escaped += body.substr(i * 64, 64) + "\\r\\n";
+	escaped += "-----END CERTIFICATE-----\\r\\n";
+	CHECK_EQUAL(readTestFile("long.cfg"), "a=1\nb=2\ncert=" + escaped + "\n");
+
+	// The value is read back as a single entry, with its line endings
+	String value;
+	char array[512];
+	int a = 0, b = 0, count = 0;
+	chunks.clear();
+	while (configFile.read("long.cfg")) {
+		configFile.get("a", a);
+		configFile.get("b", b);
+		count++;
+	}
+	while (configFile.read("long.cfg")) configFile.get("cert", value);
+	while (configFile.read("long.cfg")) configFile.get("cert", array, sizeof(array));
+	while (configFile.read("long.cfg")) configFile.get("cert", collectChunk);
+	CHECK_EQUAL(count, 3);
+	CHECK_EQUAL(a, 1);
+	CHECK_EQUAL(b, 2);
+	CHECK_EQUAL(chunks, source);
+	CHECK_EQUAL(std::string(array), source);
+	CHECK_EQUAL(std::string(value), source.substr(0, source.size() - 2));
+
+	// Escaped characters which are split between two chunks
+	for (int offset = 0; offset < 2 * SDCONFIG_BUFFER_LENGTH; offset++) {
+		std::string original = std::string(offset, 'x') + "\\\n\\\\r\r\\" + std::string(SDCONFIG_BUFFER_LENGTH, 'y') + "\\";
+		CHECK_EQUAL(roundTrip(original), original);
+	}
+
+	// Other backslashes, such as in values which weren't written in chunks, are left as they are
+	writeTestFile("long.cfg", "path=C:\\temp\\x" + std::string(SDCONFIG_BUFFER_LENGTH, 'z') + "\\\n");
+	while (configFile.read("long.cfg")) configFile.get("path", value);
+	CHECK_EQUAL(std::string(value), "C:\\temp\\x" + std::string(SDCONFIG_BUFFER_LENGTH, 'z') + "\\");
+
+	// New entries are added on their own line, even if the last line of
+	// the file has no line ending or only part of it fits in the buffer
+	writeTestFile("long.cfg", "aa=1\nbb=2");
+	while (configFile.write("long.cfg")) {
+		configFile.set("cc", 3);
+	}
+	CHECK_EQUAL(readTestFile("long.cfg"), "aa=1\nbb=2\ncc=3\n");
+
+	writeTestFile("long.cfg", "aa=1\n# comment");
+	while (configFile.write("long.cfg")) {
+		configFile.set("cc", 3);
+	}
+	CHECK_EQUAL(readTestFile("long.cfg"), "aa=1\n# comment\ncc=3\n");
+
+	std::string longLine = "dd=" + body.substr(0, 100);
+	writeTestFile("long.cfg", "aa=1\n" + longLine);
+	while (configFile.write("long.cfg")) {
+		configFile.set("cc", 3);
+	}
+	CHECK_EQUAL(readTestFile("long.cfg"), "aa=1\n" + longLine + "\ncc=3\n");
+
+	// A value on the last line is complete, even if it fills the whole buffer
+	std::string fullLine = "ee=" + body.substr(0, SDCONFIG_BUFFER_LENGTH - 4);
+	writeTestFile("long.cfg", "aa=1\n" + fullLine);
+	count = 0;
+	while (configFile.read("long.cfg")) {
+		SdConfigFile::Entry entry = configFile.entry();
+		if (count == 1) {
+			CHECK(!entry.partial);
+			CHECK_EQUAL(std::string(entry.value), fullLine.substr(3));
+		}
+		count++;
+	}
+	CHECK_EQUAL(count, 2);
+
+	return testResult("test_long_values");
+}
@@ -0,0 +1,87 @@
+/**
+ * Check that patches applied over a stream replace, add and remove
+ * entries, with the last line winning for repeated item names
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+#include <vector>
+
+SdConfigFile configFile(10);
+
+// Stream which reads from, and writes to, a string
+class StringStream : public Stream {
+public:
+	StringStream(const std::string &contents = "") : data(contents), pos(0) {}
+	size_t write(uint8_t c) { data += (char)c; return 1; }
+	int available() { return data.size() - pos; }
+	int read() { return pos < data.size() ? (unsigned char)data[pos++] : -1; }
+	int peek() { return pos < data.size() ? (unsigned char)data[pos] : -1; }
+	std::string data;
+
+private:
+	size_t pos;
+};
+
+// Split the file contents into lines, and sort them by name
+std::vector<std::string> sortedLines(const std::string &contents) {
+	std::vector<std::string> lines;
+	for (size_t start = 0, end; (end = contents.find('\n', start)) != std::string::npos; start = end + 1) {
+		lines.push_back(contents.substr(start, end - start));
+	}
+	std::sort(lines.begin(), lines.end());
+	return lines;
+}
+
+int main() {
+
+	// Replacing, adding and removing entries
+	writeTestFile("patch.cfg", "a=1\nb=2\nc=3\n");
+	StringStream simplePatch("# comment\nb = 20\nd=4\n-a\n");
+	CHECK(configFile.applyPatch("patch.cfg", simplePatch));
+	CHECK_EQUAL(readTestFile("patch.cfg"), "b=20\nd=4\nc=3\n");
+
+	// A name which appears several times only keeps its last line,
+	// including when the last line removes it
+	writeTestFile("patch.cfg", "a=1\nb=2\nc=3\n");
+	StringStream repeatPatch("b=20\nb=21\nc=30\n-c\n");
+	CHECK(configFile.applyPatch("patch.cfg", repeatPatch));
+	CHECK_EQUAL(readTestFile("patch.cfg"), "b=21\na=1\n");
+
+	// Patches with more names than fit in the list are merged in several passes
+	std::string contents, patch;
+	for (int i = 0; i < 50; i++) {
+		char line[32];
+		snprintf(line, sizeof(line), "item%02d=%d\n", i, i);
+		contents += line;
+		snprintf(line, sizeof(line), "item%02d=%d\n", i, i * 10);
+		patch += line;
+	}
+	patch += "item00=last\n";
+	writeTestFile("patch.cfg", contents);
+	StringStream largePatch(patch);
+	CHECK(configFile.applyPatch("patch.cfg", largePatch));
+
+	int count = 0;
+	while (configFile.read("patch.cfg")) {
+		SdConfigFile::Entry entry = configFile.entry();
+		int index = atoi(entry.key + 4);
+		char value[16];
+		snprintf(value, sizeof(value), "%d", index * 10);
+		if (index == 0) CHECK_EQUAL(std::string(entry.value), "last");
+		else CHECK_EQUAL(std::string(entry.value), value);
+		count++;
+	}
+	CHECK_EQUAL(count, 50);
+
+	// Exporting the file and patching it back gives the same entries, although
+	// entries from each pass of a large patch are moved to the top of the file
+	StringStream exported;
+	CHECK(configFile.exportTo("patch.cfg", exported));
+	std::string before = readTestFile("patch.cfg");
+	CHECK(configFile.applyPatch("patch.cfg", exported));
+	CHECK_EQUAL(sortedLines(readTestFile("patch.cfg")), sortedLines(before));
+
+	return testResult("test_patch");
+}
@@ -0,0 +1,143 @@
+/**
+ * Check the binary search lookup in sorted config files, including
+ * files with lines much longer than the line buffer and missing keys
+ */
+
+#include "SdConfigFile.h"
+#include "test.h"
+
+SdConfigFile configFile(10);
+
+// Simple random number generator, so the test files are the same on every host
+static unsigned long randomState = 1;
+static int randomNumber(int range) {
+	randomState = randomState * 1103515245UL + 12345UL;
+	return (int)((randomState >> 16) % range);
+}
+
+// Build a sorted file with long comments and long values mixed in
+static int writeSortedFile(const char *fileName, unsigned long seed) {
+	std::string contents;
+	int keyCount = 50 + seed * 30;
+	randomState = seed;
+
+	for (int i = 0; i < keyCount; i++) {
+		char line[32];
+		if (randomNumber(40) == 0) contents += "# " + std::string(200 + randomNumber(900), 'c') + "\n";
+
+		snprintf(line, sizeof(line), "k%04d=", i);
+		contents += line;
+
+		if (randomNumber(30) == 0) {
+			contents += std::string(200 + randomNumber(900), 'v') + "\n";
+		} else {
+			snprintf(line, sizeof(line), "%d\n", i);
+			contents += line;
+		}
+	}
+
+	writeTestFile(fileName, contents);
+	return keyCount;
+}
+
+int main() {
+
+	// Look up every key, and a missing key which sorts just after each of them
+	int missing = 0;
+	int wrong = 0;
+	int seekFailures = 0;
+	long maxBytesRead = 0;
+
+	for (unsigned long seed = 1; seed <= 12; seed++) {
+		int keyCount = writeSortedFile("lookup.cfg", seed);
+
+		for (int i = 0; i < keyCount; i++) {
+			char key[16];
+			snprintf(key, sizeof(key), "k%04dx", i);
+			resetOpCounts();
+			if (configFile.lookup("lookup.cfg", key)) wrong++;
+			seekFailures += sdOps.seekFailures;
+
+			key[5] = '\0';
+			resetOpCounts();
+			bool found = configFile.lookup("lookup.cfg", key);
+			seekFailures += sdOps.seekFailures;
+			maxBytesRead = std::max(maxBytesRead, sdOps.bytesRead);
+
+			if (found) {
+				String value;
+				configFile.get(key, value);
+				if (value.size() >= 200) {
+					if (value.find_first_not_of('v') != std::string::npos) wrong++;
+				} else if (atoi(value.c_str()) != i) {
+					wrong++;
+				}
+			} else {
+				missing++;
+			}
+		}
+
+		// Keys before the first and after the last entry
+		CHECK(configFile.lookup("lookup.cfg", "a") == false);
+		CHECK(configFile.lookup("lookup.cfg", "z") == false);
+	}
+
+	CHECK_EQUAL(missing, 0);
+	CHECK_EQUAL(wrong, 0);
+	CHECK_EQUAL(seekFailures, 0);
+
+	// The largest file is about 20 kB; a lookup should only read about ten sectors of it
+	CHECK(maxBytesRead < 10 * 512);
+
+	// Writing in sorted mode keeps the file in order
+	int keyCount = writeSortedFile("lookup.cfg", 12);
+	int replaced = 0;
+	int inserted = 0;
+	configFile.setSortedMode(true);
+	while (configFile.write("lookup.cfg")) {
+		if (configFile.set("k0003", 3)) replaced++;
+		configFile.set("k0201", 201);
+		if (configFile.set("k0201x", 2011)) inserted++;
+		configFile.set("k0500", 500);
+		configFile.set("a", 0);
+	}
+	configFile.setSortedMode(false);
+
+	// Replacing an existing entry counts as a match, adding a new one doesn't
+	CHECK_EQUAL(replaced, 1);
+	CHECK_EQUAL(inserted, 0);
+
+	std::string previous;
+	bool sorted = true;
+	int entries = 0;
+	for (auto entry : configFile.entries("lookup.cfg")) {
+		if (previous >= entry.key) sorted = false;
+		previous = entry.key;
+		entries++;
+	}
+	CHECK(sorted);
+	CHECK_EQUAL(entries, keyCount + 3);
+
+	int value = 0;
+	CHECK(configFile.lookup("lookup.cfg", "k0201"));
+	configFile.get("k0201", value);
+	CHECK_EQUAL(value, 201);
+	CHECK(configFile.lookup("lookup.cfg", "k0201x"));
+	configFile.get("k0201x", value);
+	CHECK_EQUAL(value, 2011);
+	CHECK(configFile.lookup("lookup.cfg", "a"));
+	CHECK(configFile.lookup("lookup.cfg", "k0500"));
+
+	// Finding the last entry of a file without a trailing line ending
+	// closes the file, so that other files can be read afterwards
+	writeTestFile("last.cfg", "a=1\nb=22");
+	writeTestFile("other.cfg", "x=1\ny=2\n");
+	CHECK(configFile.lookup("last.cfg", "b"));
+	configFile.get("b", value);
+	CHECK_EQUAL(value, 22);
+	entries = 0;
+	while (configFile.read("other.cfg")) entries++;
+	CHECK_EQUAL(entries, 2);
+
+	return testResult("test_sorted_lookup");
+}
@@ -50,11 +50,17 @@
  */
 SdConfigFile::SdConfigFile(uint8_t chipSelectPin) : chipSelect(chipSelectPin) {
 	lineOverflow = false;
-	commentActive = false;
 	writeAppend = false;
 	equalsSplit = false;
 	paramFound = false;
+	valueStart = false;
+	escapePending = false;
 	currentPos = NULL;
+	keyPos = NULL;
+	valuePos = NULL;
+	sourceFile = NULL;
+	sortedMode = false;
+	sortKey[0] = '\0';
 }
 
 
@@ -72,23 +78,18 @@ bool SdConfigFile::openConfigFile(const char* fileName) {
 		return false;
 	}
 
-	// Check that the file exists
-	if (!sd.exists(fileName)) {
-		Serial.println(F("Config file not found"));
-		return false;
-	}
-
 	// If another file is already open, close it
 	if (origFile) origFile.close();
 
-	// Try opening the file
+	// Try opening the file; this fails if the file doesn't exist,
+	// so there is no need to look it up separately beforehand
 	if (!origFile.open(fileName, FILE_READ)) {
-		Serial.println(F("Can't open the config file"));
+		Serial.println(F("Config file not found"));
 		return false;
 	}
 
-	commentActive = false;
 	lineOverflow = false;
+	keyPos = NULL;
 	return true;
 }
 
@@ -111,25 +112,15 @@ bool SdConfigFile::openTempFile() {
 		}
 
 		strcpy(lineBuffer, "_temp");
-		lineBuffer[5] = i;
+		lineBuffer[5] = '0' + i;
 		lineBuffer[6] = '\0';
 
-		// Check that the file exists
-		if (sd.exists(lineBuffer)) {
-			if (!sd.remove(lineBuffer)) continue;
-		}
-
-		// Try opening the file
-		if (!tempFile.open(lineBuffer, FILE_WRITE)) {
+		// Create the file, or empty it if it was left over from before
+		if (!tempFile.open(lineBuffer, O_RDWR | O_CREAT | O_TRUNC)) {
 			Serial.println(F("Unable to open temporary file"));
 			continue;
 		}
 
-		// Open and close file to create it
-		tempFile.print("");
-		tempFile.close();
-		tempFile.open(lineBuffer, FILE_WRITE);
-
 		return true;
 	}
 
@@ -148,43 +139,29 @@ bool SdConfigFile::readConfigLine() {
 
 		while (origFile.available()) {
 
+			// If the previous entry was removed, any remaining parts of its line are dropped too
+			bool dropLine = (currentPos == NULL);
 			printLineToFile();
 
+			// Remember the previous name, so that new entries can be inserted in order
+			if (keyPos && sortedMode) strcpy(sortKey, keyPos);
+
 			// Read in a new line - Note: removes '\r' but leaves '\n'
 			int bufferLength = origFile.fgets(lineBuffer, sizeof(lineBuffer));
-			lineOverflow = true;
+			bool continuation = lineOverflow;
+			lineOverflow = lineContinues(bufferLength);
 			equalsSplit = false;
 			currentPos = lineBuffer;
+			keyPos = NULL;
 
-			// Line needs to be at least three characters in length to be valid
-			// (eg. v=1) Lines shorted than this can't contain any useful info
-			if (bufferLength > 3) {
-
-				// Check that no line overflow has occurred
-				if (lineBuffer[bufferLength - 1] == '\n') {
-					lineOverflow = false;
-				}
-
-				// If we are still in a comment line, continue skipping
-				if (commentActive) {
-					if (!lineOverflow) commentActive = false;
-					continue;
-				}
-
-				// Check if line is commented out
-				if ((lineBuffer[0] == '#') || (lineBuffer[0] == '/' && lineBuffer[1] == '/')) {
-					if (lineOverflow) commentActive = true;
-					continue;
-				}
-
-				// Split at equals sign
-				currentPos = strtok(lineBuffer, "=");
-
-				// If no equals sign was present, then the string doesn't contain a parameter
-				if ((int)strlen(currentPos) == bufferLength && !lineOverflow) {
-					continue;
-				}
+			// Remainder of a line which didn't fit in the buffer; pass it straight through
+			if (continuation) {
+				if (dropLine) currentPos = NULL;
+				continue;
+			}
 
+			if (splitConfigLine(bufferLength)) {
+				currentPos = keyPos;
 				paramFound = false;
 				equalsSplit = true;
 				return true;
@@ -192,6 +169,8 @@ bool SdConfigFile::readConfigLine() {
 		}
 
 		printLineToFile();
+		if (keyPos && sortedMode) strcpy(sortKey, keyPos);
+		keyPos = NULL;
 
 		// Close the config file
 		if (origFile) origFile.close();
@@ -201,6 +180,259 @@ bool SdConfigFile::readConfigLine() {
 }
 
 
+/**
+ * Split a line from the config file into the parameter name and value
+ * 
+ * @param[in]  bufferLength  The number of characters read into the line buffer
+ * @return     True if the line contains a configuration parameter, false otherwise
+ */
+bool SdConfigFile::splitConfigLine(int bufferLength) {
+
+	// Line needs to be at least three characters in length to be valid
+	// (eg. v=1) Lines shorted than this can't contain any useful info
+	if (bufferLength <= 3) return false;
+
+	// Check if line is commented out
+	if ((lineBuffer[0] == '#') || (lineBuffer[0] == '/' && lineBuffer[1] == '/')) {
+		return false;
+	}
+
+	// Split at the first equals sign, so that values may contain them too.
+	// If no equals sign was present, then the string doesn't contain a parameter
+	valuePos = strchr(lineBuffer, '=');
+	if (valuePos == NULL) return false;
+	*valuePos++ = '\0';
+
+	// Trim the name and value in place, so they can be used directly
+	keyPos = trimSpaces(lineBuffer, true);
+	valuePos = trimSpaces(valuePos, !lineOverflow);
+	return true;
+}
+
+
+/**
+ * Read the next line at the current position in the config file
+ * 
+ * Any part of the line which doesn't fit in the line buffer is
+ * left in the file, and can be skipped using "skipLineRemainder"
+ * 
+ * @return  True if the line contains a configuration parameter, false otherwise
+ */
+bool SdConfigFile::readSortedLine() {
+	int bufferLength = origFile.fgets(lineBuffer, sizeof(lineBuffer));
+	lineOverflow = lineContinues(bufferLength);
+	keyPos = NULL;
+	return splitConfigLine(bufferLength);
+}
+
+
+/**
+ * Check whether the line in the line buffer continues in the file
+ * 
+ * The line only overflows if it doesn't end in a line ending and more data
+ * follows, so the last line of a file without a trailing line ending is complete.
+ * 
+ * @param[in]  bufferLength  The number of characters read into the line buffer
+ * @return     True if more of the line is left to read, false otherwise
+ */
+bool SdConfigFile::lineContinues(int bufferLength) {
+	return bufferLength > 0 && lineBuffer[bufferLength - 1] != '\n' && origFile.available();
+}
+
+
+/**
+ * Skip over the rest of a line which didn't fit in the line buffer
+ */
+void SdConfigFile::skipLineRemainder() {
+	while (lineOverflow && origFile.available()) {
+		int bufferLength = origFile.fgets(lineBuffer, sizeof(lineBuffer));
+		lineOverflow = lineContinues(bufferLength);
+	}
+	lineOverflow = false;
+}
+
+
+/**
+ * Read the next chunk of the value belonging to the matched config entry
+ * 
+ * The first chunk is the part of the value already held in the line buffer;
+ * any remainder of a line longer than the buffer is then read from the file
+ * one buffer at a time. The chunk is stored at "currentPos".
+ * 
+ * @param[in]  unescape  Whether escaped line endings and backslashes are turned back
+ * @return  The length of the chunk, or -1 if the whole value has been read
+ */
+int SdConfigFile::readValueChunk(bool unescape) {
+
+	int chunkLength;
+
+	if (valueStart) {
+		valueStart = false;
+		escapePending = false;
+		chunkLength = strlen(currentPos);
+	} else if (lineOverflow && origFile.available()) {
+		// A backslash held back from the end of the previous chunk goes in front of this one
+		int offset = escapePending ? 1 : 0;
+		lineBuffer[0] = '\\';
+		escapePending = false;
+
+		chunkLength = origFile.fgets(lineBuffer + offset, sizeof(lineBuffer) - offset);
+		if (chunkLength <= 0) return -1;
+		chunkLength += offset;
+		lineOverflow = lineContinues(chunkLength);
+		currentPos = lineBuffer;
+	} else {
+		return -1;
+	}
+
+	// Remove spaces, tabs and line ending characters from the end of the value
+	if (!lineOverflow) {
+		while (chunkLength > 0 && discardChar(currentPos[chunkLength - 1])) chunkLength--;
+		currentPos[chunkLength] = '\0';
+	}
+
+	if (unescape) chunkLength = unescapeChunk(chunkLength);
+	return chunkLength;
+}
+
+
+/**
+ * Turn escaped line endings and backslashes in a value chunk back into the original characters
+ * 
+ * The two-character sequences \n, \r and \\ are replaced in place, and any
+ * other backslashes are left as they are. If the chunk ends in the middle of a
+ * sequence, the backslash is held back and added to the front of the next chunk.
+ * 
+ * @param[in]  chunkLength  The length of the chunk stored at "currentPos"
+ * @return     The length of the chunk once the sequences have been replaced
+ */
+int SdConfigFile::unescapeChunk(int chunkLength) {
+
+	int length = 0;
+
+	for (int i = 0; i < chunkLength; i++) {
+		char nextChar = currentPos[i];
+
+		if (nextChar == '\\') {
+			if (i == chunkLength - 1) {
+				if (lineOverflow) {
+					escapePending = true;
+					break;
+				}
+			} else if (currentPos[i + 1] == 'n') {
+				nextChar = '\n';
+				i++;
+			} else if (currentPos[i + 1] == 'r') {
+				nextChar = '\r';
+				i++;
+			} else if (currentPos[i + 1] == '\\') {
+				i++;
+			}
+		}
+
+		currentPos[length++] = nextChar;
+	}
+
+	currentPos[length] = '\0';
+	return length;
+}
+
+
+/**
+ * Replace the configuration file with the temporary file
+ * 
+ * @param[in]  fileName  The name and path of the config file to replace
+ * @return     True if the temporary file was renamed successfully, false otherwise
+ */
+bool SdConfigFile::replaceConfigFile(const char* fileName) {
+
+	// Delete the original configuration file and rename the temporary file.
+	// If there is no original file the removal fails, which is fine
+	sd.remove(fileName);
+
+	bool success = tempFile.rename(fileName);
+	if (!success) Serial.println(F("Unable to rename temporary file"));
+
+	tempFile.close();
+	return success;
+}
+
+
+/**
+ * Copy the configuration file to the temporary file, dropping any patched entries
+ * 
+ * @param[in]  fileName    The name and path of the config file to patch
+ * @param[in]  patchKeys   List of null-terminated item names which should be dropped
+ * @param[in]  keysLength  Total length of the item name list
+ * @return     True if the configuration file was updated successfully, false otherwise
+ */
+bool SdConfigFile::mergePatch(const char* fileName, const char *patchKeys, int keysLength) {
+
+	// If no original file exists, the temporary file becomes the new config file
+	if (openConfigFile(fileName)) {
+		while (origFile && tempFile) {
+			if (readConfigLine() && currentPos) {
+				if (findPatchKey(patchKeys, keysLength, currentPos)) currentPos = NULL;
+			}
+		}
+	}
+
+	return replaceConfigFile(fileName);
+}
+
+
+/**
+ * Check whether an item name is in the list of patched names
+ * 
+ * @param[in]  patchKeys   List of null-terminated item names
+ * @param[in]  keysLength  Total length of the item name list
+ * @param[in]  itemName    The configuration item name to look for
+ * @return     True if the name is in the list, false otherwise
+ */
+bool SdConfigFile::findPatchKey(const char *patchKeys, int keysLength, const char *itemName) {
+	for (const char *key = patchKeys; key < patchKeys + keysLength; key += strlen(key) + 1) {
+		if (strcmp(key, itemName) == 0) return true;
+	}
+	return false;
+}
+
+
+/**
+ * Print the item name to the temporary file, if its new value should be written now
+ * 
+ * Normally new values are added once the end of the file is reached. In sorted
+ * mode they are written in place of the existing entry, or just before the first
+ * entry which comes after them.
+ * 
+ * @param[in]  itemName  The configuration item name
+ * @param[out] itemFound Set to true if the value replaces the current entry in place
+ * @return     True if the item name was printed and the value should follow, false otherwise
+ */
+bool SdConfigFile::printItemName(const char *itemName, bool &itemFound) {
+
+	if (!tempFile) return false;
+
+	if (writeAppend) {
+		// Items which come before the last entry were already written in place
+		if (sortedMode && strcmp(itemName, sortKey) <= 0) return false;
+	} else {
+		if (!sortedMode || keyPos == NULL) return false;
+		if (strcmp(sortKey, itemName) >= 0 || strcmp(itemName, keyPos) > 0) return false;
+
+		// Replace the existing entry with the same name
+		if (strcmp(itemName, keyPos) == 0) {
+			paramFound = true;
+			itemFound = true;
+			currentPos = NULL;
+		}
+	}
+
+	tempFile.print(itemName);
+	tempFile.print("=");
+	return true;
+}
+
+
 /**
  * Print data to temporary file
  */
@@ -209,10 +441,17 @@ void SdConfigFile::printLineToFile() {
 		tempFile.print(currentPos);
 
 		if (equalsSplit) {                  // If the line was already split
-			currentPos = strtok(NULL, "="); // Get the value on other side of the equals sign
-			checkItemName("");              // Strips spaces, etc. from the value
+			currentPos = valuePos;          // Get the value on other side of the equals sign
 			tempFile.print("=");            // Add in the equals sign again 
-			tempFile.println(currentPos);   // Print the value to the file
+
+			if (lineOverflow) {             // Rest of the value follows in the next chunks,
+				tempFile.print(currentPos); // so it is printed without a line ending
+			} else {
+				checkItemName("");          // Strips spaces, etc. from the value
+				tempFile.println(currentPos); // Print the value to the file
+			}
+		} else if (!lineOverflow && currentPos[0] != '\0' && currentPos[strlen(currentPos) - 1] != '\n') {
+			tempFile.println();             // End the last line of the file
 		}
 	}
 }
@@ -263,6 +502,250 @@ bool SdConfigFile::read(const char* fileName) {
 }
 
 
+/**
+ * Read all configuration files in a directory using a callback function
+ * 
+ * The SD card is only initialised once and the files are opened directly from
+ * the directory, in order of their names. Each pass over the directory sorts
+ * the next SDCONFIG_DIR_BATCH names, so a few passes are enough even for large
+ * directories. The name of the file which is being read is available in the
+ * "file" field of the current entry.
+ * 
+ * @param[in]  dirName    The path of the directory containing the config files
+ * @param[in]  extension  Only read files ending with this extension (eg. ".cfg"), or NULL for all files
+ * @param[in]  callbackFunction  The function to run when there is data available to parse
+ * @return     True if all files were read successfully, false otherwise
+ * @note       This can't be used while a config file is being written
+ */
+bool SdConfigFile::readDirectory(const char* dirName, const char* extension, void (*callbackFunction)()) {
+
+	decltype(origFile) dirFile;
+	decltype(origFile) entryFile;
+	char fileNames[SDCONFIG_DIR_BATCH][SDCONFIG_NAME_LENGTH];
+	char lastName[SDCONFIG_NAME_LENGTH] = "";
+	char nextName[SDCONFIG_NAME_LENGTH];
+	int extensionLength = extension ? strlen(extension) : 0;
+	bool moreFiles = true;
+	bool success = true;
+
+	if (!callbackFunction) return false;
+
+	// Lines which are read are copied to the temporary file while writing, and
+	// the config file being written would be closed, so the two can't be mixed
+	if (tempFile) {
+		Serial.println(F("Can't read a directory while writing"));
+		return false;
+	}
+
+	// Try connecting to the SD card
+	if (!sd.begin(chipSelect)) {
+		sd.initErrorPrint(&Serial);
+		return false;
+	}
+
+	if (!dirFile.open(dirName, O_RDONLY) || !dirFile.isDir()) {
+		Serial.println(F("Config directory not found"));
+		if (dirFile) dirFile.close();
+		return false;
+	}
+
+	// If another file is already open, close it
+	if (origFile) origFile.close();
+
+	while (moreFiles) {
+
+		int fileCount = 0;
+		moreFiles = false;
+		dirFile.rewindDirectory();
+
+		// Collect the lowest names which come after the previous batch, in order
+		while (entryFile.openNext(&dirFile, O_RDONLY)) {
+			int nameLength = entryFile.isDir() ? 0 : entryFile.getName(nextName, sizeof(nextName));
+			entryFile.close();
+
+			if (nameLength < extensionLength || nameLength == 0) continue;
+			if (extension && strcasecmp(nextName + nameLength - extensionLength, extension) != 0) continue;
+			if (strcmp(nextName, lastName) <= 0) continue;
+
+			// Find where the name belongs in the batch; if it is full,
+			// the highest name is dropped and left for the next pass
+			int position = fileCount;
+			while (position > 0 && strcmp(nextName, fileNames[position - 1]) < 0) position--;
+
+			if (fileCount == SDCONFIG_DIR_BATCH) {
+				moreFiles = true;
+				if (position == fileCount) continue;
+			} else {
+				fileCount++;
+			}
+
+			memmove(fileNames[position + 1], fileNames[position], (fileCount - 1 - position) * SDCONFIG_NAME_LENGTH);
+			strcpy(fileNames[position], nextName);
+		}
+
+		for (int i = 0; i < fileCount; i++) {
+
+			// Open the file relative to the directory, without looking up the full path again
+			if (!origFile.open(&dirFile, fileNames[i], O_RDONLY)) {
+				Serial.println(F("Can't open the config file"));
+				success = false;
+				continue;
+			}
+
+			sourceFile = fileNames[i];
+			lineOverflow = false;
+
+			while (origFile) {
+				if (readConfigLine()) {
+					if (currentPos) callbackFunction();
+				}
+			}
+		}
+
+		if (fileCount > 0) strcpy(lastName, fileNames[fileCount - 1]);
+	}
+
+	dirFile.close();
+	sourceFile = NULL;
+	return success;
+}
+
+
+/**
+ * Get the config entry which is currently being read
+ * 
+ * @return  The name and value of the entry, or NULL pointers if there is no current entry
+ * @note    The strings point into the line buffer, and are only valid until the next
+ *          line is read or the value is retrieved using one of the chunked "get" methods
+ */
+SdConfigFile::Entry SdConfigFile::entry() {
+	Entry current;
+	current.key = keyPos;
+	current.value = keyPos ? valuePos : NULL;
+	current.partial = keyPos ? lineOverflow : false;
+	current.file = sourceFile;
+	return current;
+}
+
+
+/**
+ * Iterate over all entries in the SD card config file using a range-based for loop
+ * 
+ * @param[in]  fileName  The name and path of the config file to open
+ * @return     A range which reads the next entry of the file each time it is advanced
+ */
+SdConfigFile::EntryRange SdConfigFile::entries(const char* fileName) {
+	return EntryRange(this, fileName);
+}
+
+
+/**
+ * Find a config entry in a sorted config file, using a binary search
+ * 
+ * The file is bisected by seeking to the middle of the remaining range and
+ * reading the first entry after the next line ending, so only O(log n) lines
+ * are read. If the entry is found it becomes the current entry, and the value
+ * can be retrieved using the "get" methods. The file must have been written
+ * in sorted mode, otherwise entries may not be found.
+ * 
+ * @param[in]  fileName  The name and path of the sorted config file
+ * @param[in]  itemName  The configuration item name to look for
+ * @return     True if the entry was found, false otherwise
+ * @note       If the value is longer than the line buffer, the file is left
+ *             open and the value should be retrieved straight away
+ */
+bool SdConfigFile::lookup(const char* fileName, const char *itemName) {
+
+	if (!openConfigFile(fileName)) return false;
+
+	// The entry, if present, starts somewhere between these two positions
+	uint32_t lowerPos = 0;
+	uint32_t upperPos = origFile.fileSize();
+	bool found = false;
+
+	// Bisect the file until the remaining range fits in about one sector
+	while (upperPos - lowerPos > 512) {
+		uint32_t middlePos = lowerPos + (upperPos - lowerPos) / 2;
+
+		// Move to the start of the first line after the middle position
+		origFile.seekSet(middlePos - 1);
+		lineOverflow = true;
+		skipLineRemainder();
+
+		// Find the first parameter entry from there
+		bool entryFound = false;
+		while (origFile.available() && !(entryFound = readSortedLine())) skipLineRemainder();
+
+		int compare = entryFound ? strcmp(itemName, keyPos) : -1;
+		if (compare == 0) {
+			found = true;
+			break;
+		} else if (compare < 0) {
+			upperPos = middlePos;
+		} else {
+			// The entry can only start after this line. If the line reaches
+			// past the upper position, the entry isn't in the file at all
+			skipLineRemainder();
+			lowerPos = origFile.curPosition();
+			if (lowerPos > upperPos) lowerPos = upperPos;
+		}
+	}
+
+	// Check the remaining lines one by one
+	if (!found) {
+		origFile.seekSet(lowerPos);
+		lineOverflow = false;
+
+		while (origFile.available() && origFile.curPosition() < upperPos) {
+			if (readSortedLine()) {
+				int compare = strcmp(itemName, keyPos);
+				if (compare == 0) {
+					found = true;
+					break;
+				} else if (compare < 0) {
+					break;
+				}
+			}
+			skipLineRemainder();
+		}
+	}
+
+	if (!found) {
+		keyPos = NULL;
+		origFile.close();
+		return false;
+	}
+
+	// Make the entry available to the "get" methods
+	currentPos = keyPos;
+	paramFound = false;
+	equalsSplit = true;
+
+	// Only leave the file open if more of the value is left to read
+	if (!lineOverflow || !origFile.available()) {
+		lineOverflow = false;
+		origFile.close();
+	}
+	return true;
+}
+
+
+/**
+ * Keep the entries in the config file sorted by name while writing
+ * 
+ * New entries are inserted in order and updated entries keep their position,
+ * rather than being added to the bottom of the file. This allows entries to
+ * be found quickly using the "lookup" method.
+ * 
+ * @param[in]  sorted  True to enable sorted mode, false to disable it
+ * @note       If several new entries are added in the same place at once,
+ *             their "set" methods need to be called in order of their names
+ */
+void SdConfigFile::setSortedMode(bool sorted) {
+	sortedMode = sorted;
+}
+
+
 /**
  * Write the new configurations to the SD card config file using a while loop
  * 
@@ -279,6 +762,7 @@ bool SdConfigFile::write(const char* fileName) {
 		}
 		writeAppend = false;
 		currentPos = NULL;
+		sortKey[0] = '\0';
 	}
 
 	if (!writeAppend) {
@@ -306,14 +790,7 @@ bool SdConfigFile::write(const char* fileName) {
 		return true;
 	}
 
-	// Delete the original configuration file and rename the temporary file
-	if (!sd.exists(fileName) || sd.remove(fileName)) {
-		if (!tempFile.rename(fileName)) {
-			Serial.println(F("Unable to rename temporary file"));
-		}
-	}
-	
-	tempFile.close();
+	replaceConfigFile(fileName);
 	writeAppend = false;
 
 	return false;
@@ -339,6 +816,180 @@ bool SdConfigFile::write(const char* fileName, void (*callbackFunction)()) {
 
 
 
+///////////////////////////////////////////////////////////////
+//
+// Stream export and patch import methods
+//
+///////////////////////////////////////////////////////////////
+
+#ifdef ARDUINO
+/**
+ * Export all config entries to an output stream
+ * 
+ * Each entry is printed as a "name=value" line, with comments and
+ * empty lines left out. Long values are printed chunk by chunk, and
+ * escaped line endings are left as they are stored in the file.
+ * 
+ * @param[in]  fileName  The name and path of the config file to export
+ * @param[out] output    The Print object (eg. Serial) to write the entries to
+ * @return     True if the export completed successfully, false otherwise
+ * @note       This method is only available for Arduino
+ */
+bool SdConfigFile::exportTo(const char* fileName, Print &output) {
+
+	if (!openConfigFile(fileName)) return false;
+
+	while (origFile) {
+		if (readConfigLine() && currentPos) {
+			output.print(keyPos);
+			output.print('=');
+
+			// Values are exported as they are stored, so that
+			// escaped line endings stay on a single line
+			if (checkItemName(keyPos)) {
+				int chunkLength;
+				while ((chunkLength = readValueChunk(false)) >= 0) {
+					output.write(currentPos, chunkLength);
+				}
+				currentPos = NULL;
+			}
+
+			output.println();
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * Apply a patch received from an input stream to the config file
+ * 
+ * Each "name=value" line of the patch adds or updates an entry, while a
+ * "-name" line removes the entry from the file. Comments and empty lines
+ * are skipped, and the patch ends once the stream times out. The new entries
+ * are written straight to the temporary file, so only the item names are
+ * kept in memory. If these don't fit in SDCONFIG_PATCH_LENGTH, or an item
+ * appears more than once, the patch is merged into the file in several passes
+ * so that the last line for each item wins.
+ * 
+ * @param[in]  fileName  The name and path of the config file to patch
+ * @param[in]  source    The Stream object (eg. Serial) to read the patch from
+ * @return     True if the patch was applied successfully, false otherwise
+ * @note       This method is only available for Arduino
+ */
+bool SdConfigFile::applyPatch(const char* fileName, Stream &source) {
+
+	char patchKeys[SDCONFIG_PATCH_LENGTH];
+	int keysLength = 0;
+	bool success = true;
+
+	if (!openTempFile()) return false;
+	currentPos = NULL;
+
+	while (readStreamChunk(source) >= 0) {
+
+		char *itemName = trimSpaces(lineBuffer, !lineOverflow);
+		char *itemValue = strchr(itemName, '=');
+		bool removeItem = (itemName[0] == '-');
+
+		// Skip comments and lines which don't contain a parameter
+		if (itemName[0] == '#' || (itemName[0] == '/' && itemName[1] == '/') || (!removeItem && !itemValue)) {
+			while (lineOverflow && readStreamChunk(source) >= 0);
+			continue;
+		}
+
+		if (removeItem) {
+			itemName = trimSpaces(itemName + 1, true);
+		} else {
+			*itemValue++ = '\0';
+			itemName = trimSpaces(itemName, true);
+		}
+
+		if (itemName[0] == '\0') {
+			while (lineOverflow && readStreamChunk(source) >= 0);
+			continue;
+		}
+
+		// If the item was already patched, or the list of names is full, merge the
+		// patch so far into the config file first, so that the last line wins
+		if (findPatchKey(patchKeys, keysLength, itemName) || (int)sizeof(patchKeys) - keysLength <= (int)strlen(itemName)) {
+			char lineCopy[SDCONFIG_BUFFER_LENGTH];
+			bool overflow = lineOverflow;
+			memcpy(lineCopy, lineBuffer, sizeof(lineBuffer));
+
+			success = mergePatch(fileName, patchKeys, keysLength) && success;
+			keysLength = 0;
+
+			if (!openTempFile()) return false;
+			currentPos = NULL;
+
+			// Restore the current line, which was overwritten while merging
+			memcpy(lineBuffer, lineCopy, sizeof(lineBuffer));
+			lineOverflow = overflow;
+		}
+
+		// Remember the item name, so that it can be dropped from the original file
+		strcpy(patchKeys + keysLength, itemName);
+		keysLength += strlen(itemName) + 1;
+
+		if (removeItem) {
+			while (lineOverflow && readStreamChunk(source) >= 0);
+		} else {
+			// Write the new entry to the temporary file, one chunk at a time
+			tempFile.print(itemName);
+			tempFile.print('=');
+			tempFile.print(trimSpaces(itemValue, !lineOverflow));
+
+			while (lineOverflow) {
+				int chunkLength = readStreamChunk(source);
+				if (chunkLength < 0) break;
+				while (!lineOverflow && chunkLength > 0 && discardChar(lineBuffer[chunkLength - 1])) chunkLength--;
+				tempFile.write(lineBuffer, chunkLength);
+			}
+
+			tempFile.println();
+		}
+	}
+
+	return mergePatch(fileName, patchKeys, keysLength) && success;
+}
+
+
+/**
+ * Read the next chunk of a line from an input stream into the line buffer
+ * 
+ * @param[in]  source  The Stream object to read from
+ * @return     The length of the chunk, or -1 if the stream timed out
+ */
+int SdConfigFile::readStreamChunk(Stream &source) {
+
+	int chunkLength = 0;
+	char nextChar;
+	lineOverflow = true;
+
+	while (chunkLength < (int)sizeof(lineBuffer) - 1) {
+		if (source.readBytes(&nextChar, 1) != 1) {
+			lineOverflow = false;
+			if (chunkLength == 0) return -1;
+			break;
+		}
+
+		if (nextChar == '\n') {
+			lineOverflow = false;
+			break;
+		}
+
+		if (nextChar != '\r') lineBuffer[chunkLength++] = nextChar;
+	}
+
+	lineBuffer[chunkLength] = '\0';
+	return chunkLength;
+}
+#endif /* ARDUINO */
+
+
+
 ///////////////////////////////////////////////////////////////
 //
 // Internal utility methods
@@ -366,7 +1017,8 @@ bool SdConfigFile::checkItemName(const char *itemName) {
 	// Check if both name strings match and that the string isn't empty
 	if (strcmp(itemName, currentPos) == 0 && stringLength != 0) {
 		paramFound = true;
-		currentPos = strtok(NULL, "=");
+		valueStart = true;
+		currentPos = valuePos;
 		if (currentPos) return true;
 	}
 
@@ -374,6 +1026,25 @@ bool SdConfigFile::checkItemName(const char *itemName) {
 }
 
 
+/**
+ * Remove white-space from the start and optionally the end of a string
+ * @param[in]  str     The string to trim in place
+ * @param[in]  trimEnd Whether spaces, tabs and line endings should be removed from the end
+ * @return     Pointer to the first character of the trimmed string
+ */
+char *SdConfigFile::trimSpaces(char *str, bool trimEnd) {
+	while (str[0] == ' ' || str[0] == '\t') str++;
+
+	if (trimEnd) {
+		int stringLength = strlen(str);
+		while (stringLength > 0 && discardChar(str[stringLength - 1])) stringLength--;
+		str[stringLength] = '\0';
+	}
+
+	return str;
+}
+
+
 /**
  * Check for white-space, tab or line ending characters
  * @param[in]  currentChar The character to test
@@ -461,21 +1132,47 @@ bool SdConfigFile::get(const char *itemName, bool &itemValue) {
  * Get a string config value and save it in a character array
  * @param[in]  itemName  The configuration item name
  * @param[out] itemValue The character array where value will be saved
+ * @param[in]  maxLength The size of the character array
  * @return     True if configuration was set, false if current item name did not match
+ * @note       Values longer than the line buffer are copied across chunk by chunk
  */
 bool SdConfigFile::get(const char *itemName, char *itemValue, int maxLength) {
 	if (checkItemName(itemName)) {
-		// Remove empty spaces from front of character array
-		while (currentPos[0] == ' ') currentPos++;
-		int stringLength = strlen(currentPos);
+		int stringLength = 0;
+		int chunkLength;
+
+		// Copy each chunk of the value to the destination character array,
+		// discarding anything which doesn't fit
+		while ((chunkLength = readValueChunk()) >= 0) {
+			if (chunkLength > maxLength - 1 - stringLength) chunkLength = maxLength - 1 - stringLength;
+			memcpy(itemValue + stringLength, currentPos, chunkLength);
+			stringLength += chunkLength;
+		}
+
+		itemValue[stringLength] = '\0';
+		currentPos = NULL;
+		return true;
+	}
+	return false;
+}
 
-		// Remove spaces, tabs and line ending characters from end of character array
-		while (stringLength > 0 && discardChar(currentPos[stringLength - 1])) stringLength--;
-		if (stringLength >= maxLength) stringLength = maxLength - 1;
 
-		// Copy the string to the destination character array
-		strncpy(itemValue, currentPos, stringLength);
-		itemValue[stringLength + 1] = '\0';
+/**
+ * Get a string config value of any length, one chunk at a time
+ * @param[in]  itemName  The configuration item name
+ * @param[in]  chunkFunction The function to run for each chunk of the value
+ * @return     True if configuration was found, false if current item name did not match
+ * @note       The chunks are not null-terminated, and are only valid during the callback
+ */
+bool SdConfigFile::get(const char *itemName, void (*chunkFunction)(const char *chunk, int length)) {
+	if (checkItemName(itemName)) {
+		int chunkLength;
+
+		while ((chunkLength = readValueChunk()) >= 0) {
+			if (chunkLength > 0) chunkFunction(currentPos, chunkLength);
+		}
+
+		currentPos = NULL;
 		return true;
 	}
 	return false;
@@ -492,8 +1189,37 @@ bool SdConfigFile::get(const char *itemName, char *itemValue, int maxLength) {
 #ifdef ARDUINO
 bool SdConfigFile::get(const char *itemName, String &itemValue) {
 	if (checkItemName(itemName)) {
-		itemValue = currentPos;
+		int chunkLength;
+		itemValue = "";
+
+		while ((chunkLength = readValueChunk()) >= 0) {
+			itemValue.concat(currentPos, chunkLength);
+		}
+
 		itemValue.trim();
+		currentPos = NULL;
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * Get a string config value of any length and print it to an output stream
+ * @param[in]  itemName  The configuration item name
+ * @param[out] output    The Print object (eg. Serial or a File) to write the value to
+ * @return     True if configuration was found, false if current item name did not match
+ * @note       This method is only available for Arduino
+ */
+bool SdConfigFile::get(const char *itemName, Print &output) {
+	if (checkItemName(itemName)) {
+		int chunkLength;
+
+		while ((chunkLength = readValueChunk()) >= 0) {
+			output.write(currentPos, chunkLength);
+		}
+
+		currentPos = NULL;
 		return true;
 	}
 	return false;
@@ -516,10 +1242,10 @@ bool SdConfigFile::get(const char *itemName, String &itemValue) {
  * @return     True if configuration was set, false if current item name did not match
  */
 bool SdConfigFile::set(const char *itemName, long itemValue) {
-	if (writeAppend && tempFile) {
-		tempFile.print(itemName);
-		tempFile.print("=");
+	bool itemFound = false;
+	if (printItemName(itemName, itemFound)) {
 		tempFile.println(itemValue);
+		return itemFound;
 	} else if (checkItemName(itemName)) {
 		currentPos = NULL;
 		return true;
@@ -558,10 +1284,10 @@ bool SdConfigFile::set(const char *itemName, bool itemValue) {
  * @return     True if configuration was set, false if current item name did not match
  */
 bool SdConfigFile::set(const char *itemName, float itemValue, int precision) {
-	if (writeAppend && tempFile) {
-		tempFile.print(itemName);
-		tempFile.print("=");
+	bool itemFound = false;
+	if (printItemName(itemName, itemFound)) {
 		tempFile.println(itemValue, precision);
+		return itemFound;
 	} else if (checkItemName(itemName)) {
 		currentPos = NULL;
 		return true;
@@ -577,10 +1303,54 @@ bool SdConfigFile::set(const char *itemName, float itemValue, int precision) {
  * @return     True if configuration was set, false if current item name did not match
  */
 bool SdConfigFile::set(const char *itemName, char *itemValue) {
-	if (writeAppend && tempFile) {
-		tempFile.print(itemName);
-		tempFile.print("=");
+	bool itemFound = false;
+	if (printItemName(itemName, itemFound)) {
 		tempFile.println(itemValue);
+		return itemFound;
+	} else if (checkItemName(itemName)) {
+		currentPos = NULL;
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * Set a string config value of any length, one chunk at a time
+ * @param[in]  itemName  The configuration item name
+ * @param[in]  chunkFunction The function which fills the buffer with the next chunk
+ *             of the value and returns its length, or 0 once the value is complete
+ * @return     True if configuration was set, false if current item name did not match
+ * @note       Line endings and backslashes in the chunks are stored as \n, \r and \\,
+ *             so that multi-line values fit on a single line. The string "get"
+ *             methods turn them back into the original characters
+ */
+bool SdConfigFile::set(const char *itemName, int (*chunkFunction)(char *chunk, int maxLength)) {
+	bool itemFound = false;
+	if (printItemName(itemName, itemFound)) {
+		char chunkBuffer[SDCONFIG_BUFFER_LENGTH];
+		int chunkLength;
+
+		// The line buffer may still hold the current line, so a separate buffer is used
+		while ((chunkLength = chunkFunction(chunkBuffer, sizeof(chunkBuffer))) > 0) {
+
+			// Escape line endings, which would otherwise split the entry over several
+			// lines, and backslashes, so that the value can be turned back exactly
+			int start = 0;
+			for (int i = 0; i <= chunkLength; i++) {
+				if (i == chunkLength || chunkBuffer[i] == '\r' || chunkBuffer[i] == '\n' || chunkBuffer[i] == '\\') {
+					if (i > start) tempFile.write(chunkBuffer + start, i - start);
+					if (i < chunkLength) {
+						tempFile.print('\\');
+						tempFile.print(chunkBuffer[i] == '\r' ? 'r' : chunkBuffer[i] == '\n' ? 'n' : '\\');
+					}
+					start = i + 1;
+				}
+			}
+		}
+
+		tempFile.println();
+		return itemFound;
 	} else if (checkItemName(itemName)) {
 		currentPos = NULL;
 		return true;
@@ -598,10 +1368,10 @@ bool SdConfigFile::set(const char *itemName, char *itemValue) {
  */
 #ifdef ARDUINO
 bool SdConfigFile::set(const char *itemName, String &itemValue) {
-	if (writeAppend && tempFile) {
-		tempFile.print(itemName);
-		tempFile.print("=");
+	bool itemFound = false;
+	if (printItemName(itemName, itemFound)) {
 		tempFile.println(itemValue);
+		return itemFound;
 	} else if (checkItemName(itemName)) {
 		currentPos = NULL;
 		return true;
@@ -63,6 +63,34 @@
 #endif /* SDCONFIG_BUFFER_LENGTH */
 
 
+// When applying a patch, the names of the patched
+// parameters are kept in a buffer of this length.
+// Larger patches are merged in several passes
+#ifndef SDCONFIG_PATCH_LENGTH
+#define SDCONFIG_PATCH_LENGTH (SDCONFIG_BUFFER_LENGTH * 4)
+#endif /* SDCONFIG_PATCH_LENGTH */
+
+static_assert(SDCONFIG_PATCH_LENGTH >= SDCONFIG_BUFFER_LENGTH,
+	"SDCONFIG_PATCH_LENGTH must be at least SDCONFIG_BUFFER_LENGTH, to fit any item name");
+
+
+// Maximum length of the file names when reading
+// all config files in a directory. Files with
+// longer names are skipped
+#ifndef SDCONFIG_NAME_LENGTH
+#define SDCONFIG_NAME_LENGTH (32)
+#endif /* SDCONFIG_NAME_LENGTH */
+
+
+// When reading all config files in a directory,
+// this many file names are sorted in each pass
+// over the directory. More names take more RAM,
+// but fewer passes are needed
+#ifndef SDCONFIG_DIR_BATCH
+#define SDCONFIG_DIR_BATCH (8)
+#endif /* SDCONFIG_DIR_BATCH */
+
+
 /**
  * @class  SdConfigFile
  * @brief  Sd Card Configuration file reading and writing class
@@ -70,6 +98,52 @@
 class SdConfigFile {
 
 public:
+	/**
+	 * @brief  Name and value of a config entry, pointing into the line buffer
+	 */
+	struct Entry {
+		const char *key;
+		const char *value;
+		bool partial;      // Value continues past the end of the line buffer
+		const char *file;  // Name of the file, if reading all files in a directory
+	};
+
+	/**
+	 * @brief  Iterator which reads the next config entry each time it is advanced
+	 */
+	class EntryIterator {
+	public:
+		EntryIterator(SdConfigFile *configFile, const char *fileName) : config(configFile), name(fileName) {}
+		Entry operator*() const { return config->entry(); }
+		bool operator!=(const EntryIterator &other) const { return config != other.config; }
+		EntryIterator &operator++() {
+			if (!config->read(name)) config = NULL;
+			return *this;
+		}
+
+	private:
+		SdConfigFile *config;
+		const char *name;
+	};
+
+	/**
+	 * @brief  Range of config entries, for use in range-based for loops
+	 */
+	class EntryRange {
+	public:
+		EntryRange(SdConfigFile *configFile, const char *fileName) : config(configFile), name(fileName) {}
+		EntryIterator begin() {
+			// Start from the top of the file, even if a previous loop was left early
+			if (!config->openConfigFile(name)) return end();
+			return ++EntryIterator(config, name);
+		}
+		EntryIterator end() { return EntryIterator(NULL, name); }
+
+	private:
+		SdConfigFile *config;
+		const char *name;
+	};
+
 	// Constructor and destructor
 	SdConfigFile(uint8_t chipSelectPin);
 	~SdConfigFile() {}
@@ -77,44 +151,75 @@ public:
 	// Configuration parameter reading methods
 	bool read(const char* fileName, void (*callbackFunction)());
 	bool read(const char* fileName);
+	Entry entry();
+	EntryRange entries(const char* fileName);
+	bool readDirectory(const char* dirName, const char* extension, void (*callbackFunction)());
+	bool lookup(const char* fileName, const char *itemName);
 	bool get(const char *itemName, int &itemValue);
 	bool get(const char *itemName, float &itemValue);
 	bool get(const char *itemName, long &itemValue);
 	bool get(const char *itemName, bool &itemValue);
 	bool get(const char *itemName, char *itemValue, int maxLength);
+	bool get(const char *itemName, void (*chunkFunction)(const char *chunk, int length));
 
 	// Configuration parameter writing methods
 	bool write(const char* fileName, void (*callbackFunction)());
 	bool write(const char* fileName);
+	void setSortedMode(bool sorted);
 	bool set(const char *itemName, int itemValue);
 	bool set(const char *itemName, float itemValue, int precision = FLOAT_DECIMAL_LENGTH);
 	bool set(const char *itemName, long itemValue);
 	bool set(const char *itemName, bool itemValue);
 	bool set(const char *itemName, char *itemValue);
+	bool set(const char *itemName, int (*chunkFunction)(char *chunk, int maxLength));
 	bool remove(const char *itemName);
 
 #ifdef ARDUINO
 	// Arduino-specific read methods
 	bool read(String fileName) { return read(fileName.c_str()); }
 	bool read(String fileName, void (*callbackFunction)()) { return read(fileName.c_str(), callbackFunction); }
+	EntryRange entries(String &fileName) { return entries(fileName.c_str()); }
+	bool readDirectory(String dirName, const char* extension, void (*callbackFunction)()) { return readDirectory(dirName.c_str(), extension, callbackFunction); }
+	bool lookup(String fileName, const char *itemName) { return lookup(fileName.c_str(), itemName); }
 	bool get(const char *itemName, String &itemValue);
+	bool get(const char *itemName, Print &output);
 
 	// Arduino specific write methods
 	bool write(String fileName, void (*callbackFunction)()) { return write(fileName.c_str(), callbackFunction); }
 	bool write(String fileName) { return write(fileName.c_str()); }
 	bool set(const char *itemName, String &itemValue);
+
+	// Arduino-specific stream methods
+	bool exportTo(const char* fileName, Print &output);
+	bool exportTo(String fileName, Print &output) { return exportTo(fileName.c_str(), output); }
+	bool applyPatch(const char* fileName, Stream &source);
+	bool applyPatch(String fileName, Stream &source) { return applyPatch(fileName.c_str(), source); }
 #endif /* ARDUINO */
 	
 private:
 	// Internal utility methods
 	bool checkItemName(const char *itemName);
 	bool discardChar(char currentChar);
+	char *trimSpaces(char *str, bool trimEnd);
 
 	// Sd card file opening, reading and writing methods
 	bool openConfigFile(const char* fileName);
 	bool openTempFile();
+	bool replaceConfigFile(const char* fileName);
+	bool mergePatch(const char* fileName, const char *patchKeys, int keysLength);
+	bool findPatchKey(const char *patchKeys, int keysLength, const char *itemName);
 	bool readConfigLine();
+	bool splitConfigLine(int bufferLength);
+	bool readSortedLine();
+	bool lineContinues(int bufferLength);
+	void skipLineRemainder();
+	int readValueChunk(bool unescape = true);
+	int unescapeChunk(int chunkLength);
+	bool printItemName(const char *itemName, bool &itemFound);
 	void printLineToFile();
+#ifdef ARDUINO
+	int readStreamChunk(Stream &source);
+#endif /* ARDUINO */
 
 	// Choose the SD file system type depending
 	// on which definitions user has supplied
@@ -135,13 +240,21 @@ private:
 	// Buffer used to store each line from the config file
 	char lineBuffer[SDCONFIG_BUFFER_LENGTH];
 
+	// Name of the previous entry, used to keep the file sorted
+	char sortKey[SDCONFIG_BUFFER_LENGTH];
+
 	// State machine variables
 	char *currentPos;
+	char *keyPos;
+	char *valuePos;
+	const char *sourceFile;
 	bool lineOverflow;
-	bool commentActive;
 	bool writeAppend;
 	bool equalsSplit;
 	bool paramFound;
+	bool valueStart;
+	bool escapePending;
+	bool sortedMode;
 
 	// SD card SPI chip select pin
 	const uint8_t chipSelect;